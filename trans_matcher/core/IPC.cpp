@@ -15,23 +15,35 @@
 #include <QDialog>
 #include <QVBoxLayout>
 #include <QPushButton>
+#include <QFile>
+#include <QEventLoop>
+#include <QTimer>
+#include <QPointer>
+
+#include "core/IPCRecord.h"
 
 class IPCPrivate {
     IPC *m_p;
     QTcpServer *m_server;
 
+    IPC::Reviewer m_reviewer = IPC::dialogReviewer();
+    QString m_recordDir;
+
     struct ClientResource {
         QByteArray buffer;
+        std::unique_ptr<IPCSessionRecorder> recorder;
     };
 
     QMap<QTcpSocket *, std::shared_ptr<ClientResource> > m_clients;
 
+    friend class IPC;
+
 public:
-    IPCPrivate(IPC *p): m_p(p), m_server(new QTcpServer(p)) {
+    IPCPrivate(IPC *p, quint16 port): m_p(p), m_server(new QTcpServer(p)) {
         QObject::connect(m_server, &QTcpServer::newConnection,
                          [this]() { onNewConnection(); });
 
-        if (not m_server->listen(QHostAddress::Any, 12345)) {
+        if (not m_server->listen(QHostAddress::Any, port)) {
             qCritical() << "Failed to start IPC server:" << m_server->errorString();
         }
         qInfo() << "IPC server started on port" << m_server->serverPort();
@@ -44,15 +56,22 @@ private:
             qWarning() << "Failed to get pending connection";
             return;
         }
-        m_clients[conn] = std::make_shared<ClientResource>();
+        auto resource = std::make_shared<ClientResource>();
+        if (not m_recordDir.isEmpty()) {
+            resource->recorder = std::make_unique<IPCSessionRecorder>(
+                m_recordDir,
+                QString("%1:%2").arg(conn->peerAddress().toString()).arg(conn->peerPort()));
+        }
+        m_clients[conn] = resource;
         qInfo() << "New connection from" << conn->peerAddress().toString()
                 << ":" << conn->peerPort();
         QObject::connect(conn, &QTcpSocket::disconnected,
-                         [this,conn]() {
+                         [this,conn,resource]() {
                              // qInfo() << "Connection disconnected from"
                              //         << conn->peerAddress().toString() << ":"
                              //         << conn->peerPort();
                              // m_clients.remove(conn);
+                             resource->recorder.reset();
                              conn->deleteLater();
                          });
         QObject::connect(conn, &QTcpSocket::readyRead,
@@ -74,13 +93,23 @@ private:
         if (parseError.error != QJsonParseError::NoError) {
             return;
         }
+        resource->buffer.clear();
+        if (resource->recorder)
+            resource->recorder->record(IPCFrame::Recv, doc);
         qInfo() << "Received from"
                 << conn->peerAddress().toString() << ":"
                 << conn->peerPort();
 
+        // The reviewer runs a nested event loop; if the client goes away
+        // meanwhile, its socket is deleted inside that loop.
+        QPointer<QTcpSocket> guard(conn);
         const auto writeResponse =
-                [conn](QJsonDocument json) {
-            if (conn->write(json.toJson()) == -1) {
+                [guard,resource](QJsonDocument json) {
+            if (guard.isNull())
+                return;
+            if (resource->recorder)
+                resource->recorder->record(IPCFrame::Send, json);
+            if (guard->write(json.toJson()) == -1) {
                 qWarning() << "Failed to write response to client";
                 // TODO
             }
@@ -96,31 +125,11 @@ private:
         QString trans_label = trans["label"].toString();
         QJsonArray trans_data = trans["data"].toArray();
 
-        int ret = [&]() {
-            QDialog dialog;
-            auto vLayout = new QVBoxLayout(&dialog);
-            dialog.setLayout(vLayout);
-
-            auto matcher = new TransMatcher(&dialog);
-            matcher->setOrigin(origin);
-            matcher->setTrans(trans_label, trans_data);
-            vLayout->addWidget(matcher);
-
-            auto btnLayout = new QHBoxLayout;
-            auto acceptBtn = new QPushButton("Accept", &dialog);
-            QObject::connect(acceptBtn, &QPushButton::clicked, &dialog, &QDialog::accept);
-            btnLayout->addWidget(acceptBtn);
-            auto rejectBtn = new QPushButton("Reject", &dialog);
-            QObject::connect(rejectBtn, &QPushButton::clicked, &dialog, &QDialog::reject);
-            btnLayout->addWidget(rejectBtn);
-            vLayout->addLayout(btnLayout);
-
-            if (QDialog::Accepted == dialog.exec()) {
-                trans_data = matcher->getTrans(trans_label);
-                return 0;
-            }
-            return -1;
-        }();
+        int ret = m_reviewer(origin, trans_label, trans_data) ? 0 : -1;
+        if (guard.isNull()) {
+            qWarning() << "Client disconnected during review";
+            return;
+        }
         if (0 == ret) {
             QJsonObject accepted;
             accepted["status"] = "accepted";
@@ -138,9 +147,131 @@ private:
     }
 };
 
-IPC::IPC(): m_private(new IPCPrivate(this)) {
+IPC::IPC(): IPC(12345) {
+}
+
+IPC::IPC(quint16 port): m_private(new IPCPrivate(this, port)) {
 }
 
 IPC::~IPC() {
     delete m_private;
 }
+
+quint16 IPC::serverPort() const {
+    return m_private->m_server->serverPort();
+}
+
+void IPC::setReviewer(Reviewer reviewer) {
+    m_private->m_reviewer = std::move(reviewer);
+}
+
+void IPC::setRecordDir(const QString &dir) {
+    m_private->m_recordDir = dir;
+}
+
+IPC::Reviewer IPC::dialogReviewer() {
+    return [](const QJsonArray &origin, const QString &label, QJsonArray &trans) {
+        QDialog dialog;
+        auto vLayout = new QVBoxLayout(&dialog);
+        dialog.setLayout(vLayout);
+
+        auto matcher = new TransMatcher(&dialog);
+        matcher->setOrigin(origin);
+        matcher->setTrans(label, trans);
+        vLayout->addWidget(matcher);
+
+        auto btnLayout = new QHBoxLayout;
+        auto acceptBtn = new QPushButton("Accept", &dialog);
+        QObject::connect(acceptBtn, &QPushButton::clicked, &dialog, &QDialog::accept);
+        btnLayout->addWidget(acceptBtn);
+        auto rejectBtn = new QPushButton("Reject", &dialog);
+        QObject::connect(rejectBtn, &QPushButton::clicked, &dialog, &QDialog::reject);
+        btnLayout->addWidget(rejectBtn);
+        vLayout->addLayout(btnLayout);
+
+        if (QDialog::Accepted == dialog.exec()) {
+            trans = matcher->getTrans(label);
+            return true;
+        }
+        return false;
+    };
+}
+
+IPC::Reviewer IPC::autoReviewer(bool accept) {
+    return [accept](const QJsonArray &, const QString &, QJsonArray &) {
+        return accept;
+    };
+}
+
+// A review script stands in for the human behind the dialog:
+// {
+//     "action": "accept" | "reject",      (default "accept")
+//     "delayMs": 1500,                    think time, spent in a nested event
+//                                         loop just like QDialog::exec()
+//     "edits": [                          applied in order before accepting
+//         {"op": "insert", "row": 3},
+//         {"op": "remove", "row": 7},
+//         {"op": "set", "row": 0, "name": "...", "message": "..."}
+//     ]
+// }
+// Rows out of range are ignored, as they are by the Insert/Remove menu.
+IPC::Reviewer IPC::scriptedReviewer(const QJsonObject &script) {
+    bool accept = "reject" != script["action"].toString("accept");
+    int delayMs = script["delayMs"].toInt(0);
+    QJsonArray edits = script["edits"].toArray();
+
+    return [accept, delayMs, edits](const QJsonArray &, const QString &, QJsonArray &trans) {
+        if (delayMs > 0) {
+            QEventLoop loop;
+            QTimer::singleShot(delayMs, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        if (not accept)
+            return false;
+
+        for (const auto &value: edits) {
+            QJsonObject edit = value.toObject();
+            QString op = edit["op"].toString();
+            int row = edit["row"].toInt(-1);
+            if (row < 0 or row >= trans.size())
+                continue;
+            if ("insert" == op) {
+                trans.insert(row, QJsonValue());
+            } else if ("remove" == op) {
+                trans.removeAt(row);
+            } else if ("set" == op) {
+                QJsonObject item = trans[row].toObject();
+                if (edit.contains("name"))
+                    item["name"] = edit["name"];
+                if (edit.contains("message"))
+                    item["message"] = edit["message"];
+                trans[row] = item;
+            } else {
+                qWarning() << "Unknown review script op" << op;
+            }
+        }
+        return true;
+    };
+}
+
+IPC::Reviewer IPC::reviewerFromSpec(const QString &spec) {
+    if (spec.isEmpty() or "dialog" == spec)
+        return dialogReviewer();
+    if ("accept" == spec)
+        return autoReviewer(true);
+    if ("reject" == spec)
+        return autoReviewer(false);
+
+    QFile file(spec);
+    if (not file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Failed to open review script" << spec << ":" << file.errorString();
+        return {};
+    }
+    QJsonParseError parseError;
+    auto doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError or not doc.isObject()) {
+        qCritical() << "Invalid review script" << spec << ":" << parseError.errorString();
+        return {};
+    }
+    return scriptedReviewer(doc.object());
+}
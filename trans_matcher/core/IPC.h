@@ -6,6 +6,10 @@
 #define IPC_H
 
 #include <QObject>
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include <functional>
 
 class IPC : public QObject {
 public:
@@ -15,10 +19,38 @@ public:
         Finished,
     };
 
+    // Decides on one translation request. Returns true to accept; `trans` may be
+    // edited in place and is sent back to the client when accepted.
+    using Reviewer = std::function<bool(const QJsonArray &origin,
+                                        const QString &label,
+                                        QJsonArray &trans)>;
+
     IPC();
 
+    explicit IPC(quint16 port);
+
     ~IPC();
 
+    quint16 serverPort() const;
+
+    void setReviewer(Reviewer reviewer);
+
+    // Records every frame of every connection to a session file under `dir`.
+    // An empty path disables recording.
+    void setRecordDir(const QString &dir);
+
+    // Shows the TransMatcher dialog and waits for the user.
+    static Reviewer dialogReviewer();
+
+    static Reviewer autoReviewer(bool accept);
+
+    // See IPC.cpp for the script format.
+    static Reviewer scriptedReviewer(const QJsonObject &script);
+
+    // "dialog", "accept", "reject" or the path of a review script.
+    // Returns an empty Reviewer if the spec cannot be used.
+    static Reviewer reviewerFromSpec(const QString &spec);
+
 private:
     friend class IPCPrivate;
     IPCPrivate *m_private;
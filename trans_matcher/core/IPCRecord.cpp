@@ -0,0 +1,171 @@
+//
+// Created by Chow on 2025/7/27.
+//
+
+#include "IPCRecord.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include <algorithm>
+#include <atomic>
+
+static const char *eventName(IPCFrame::Event event) {
+    switch (event) {
+        case IPCFrame::Open:
+            return "open";
+        case IPCFrame::Recv:
+            return "recv";
+        case IPCFrame::Send:
+            return "send";
+        case IPCFrame::Close:
+            return "close";
+    }
+    return "";
+}
+
+static bool eventFromName(const QString &name, IPCFrame::Event &event) {
+    for (auto e: {IPCFrame::Open, IPCFrame::Recv, IPCFrame::Send, IPCFrame::Close}) {
+        if (name == QLatin1String(eventName(e))) {
+            event = e;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IPCSession::load(const QString &path, IPCSession &session, QString *error) {
+    const auto fail = [error, &path](const QString &msg) {
+        if (error)
+            *error = path + ": " + msg;
+        return false;
+    };
+
+    QFile file(path);
+    if (not file.open(QIODevice::ReadOnly)) {
+        return fail(file.errorString());
+    }
+
+    session = IPCSession{};
+    session.path = path;
+    int lineNo = 0;
+    while (not file.atEnd()) {
+        QByteArray line = file.readLine().trimmed();
+        ++lineNo;
+        if (line.isEmpty())
+            continue;
+
+        QJsonParseError parseError;
+        auto doc = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError) {
+            // The last line may be cut short if the server died mid-write.
+            if (file.atEnd())
+                break;
+            return fail(QString("line %1: %2").arg(lineNo).arg(parseError.errorString()));
+        }
+
+        QJsonObject obj = doc.object();
+        IPCFrame frame;
+        if (not eventFromName(obj["event"].toString(), frame.event)) {
+            return fail(QString("line %1: unknown event").arg(lineNo));
+        }
+        frame.t = obj["t"].toInteger();
+        QJsonValue data = obj["data"];
+        if (data.isObject())
+            frame.data = QJsonDocument(data.toObject());
+        else if (data.isArray())
+            frame.data = QJsonDocument(data.toArray());
+
+        if (IPCFrame::Open == frame.event) {
+            session.wall = obj["wall"].toInteger();
+            session.peer = obj["peer"].toString();
+        }
+        session.frames.append(std::move(frame));
+    }
+
+    if (session.frames.isEmpty()) {
+        return fail("empty session");
+    }
+    return true;
+}
+
+QList<IPCSession> IPCSession::loadAll(const QStringList &paths) {
+    QStringList files;
+    for (const auto &path: paths) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            QDir dir(path);
+            for (const auto &name: dir.entryList({"*.jsonl"}, QDir::Files, QDir::Name))
+                files.append(dir.filePath(name));
+        } else {
+            files.append(path);
+        }
+    }
+
+    QList<IPCSession> sessions;
+    for (const auto &file: files) {
+        IPCSession session;
+        QString error;
+        if (load(file, session, &error)) {
+            sessions.append(std::move(session));
+        } else {
+            qWarning() << "Skipping session" << error;
+        }
+    }
+    std::stable_sort(sessions.begin(), sessions.end(),
+                     [](const IPCSession &a, const IPCSession &b) { return a.wall < b.wall; });
+    return sessions;
+}
+
+IPCSessionRecorder::IPCSessionRecorder(const QString &dir, const QString &peer) {
+    static std::atomic<int> counter = 0;
+
+    QDir().mkpath(dir);
+    QString name = QString("session_%1_%2.jsonl")
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss_zzz"))
+            .arg(counter++, 4, 10, QChar('0'));
+    m_file.setFileName(QDir(dir).filePath(name));
+    if (not m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open session record" << m_file.fileName()
+                << ":" << m_file.errorString();
+        return;
+    }
+    m_timer.start();
+
+    QJsonObject open;
+    open["t"] = 0;
+    open["event"] = eventName(IPCFrame::Open);
+    open["wall"] = QDateTime::currentMSecsSinceEpoch();
+    open["peer"] = peer;
+    m_file.write(QJsonDocument(open).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_file.flush();
+}
+
+IPCSessionRecorder::~IPCSessionRecorder() {
+    if (isOpen())
+        record(IPCFrame::Close);
+}
+
+void IPCSessionRecorder::record(IPCFrame::Event event, const QJsonDocument &data) {
+    if (not isOpen())
+        return;
+
+    QJsonObject line;
+    line["t"] = m_timer.elapsed();
+    line["event"] = eventName(event);
+    if (data.isObject())
+        line["data"] = data.object();
+    else if (data.isArray())
+        line["data"] = data.array();
+    m_file.write(QJsonDocument(line).toJson(QJsonDocument::Compact));
+    m_file.write("\n");
+    m_file.flush();
+
+    if (IPCFrame::Close == event)
+        m_file.close();
+}
@@ -0,0 +1,61 @@
+//
+// Created by Chow on 2025/7/27.
+//
+
+#ifndef IPCRECORD_H
+#define IPCRECORD_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QList>
+#include <QString>
+
+// One line of a session file. `t` is milliseconds since the connection opened.
+struct IPCFrame {
+    enum Event {
+        Open,
+        Recv,
+        Send,
+        Close,
+    };
+
+    qint64 t = 0;
+    Event event = Open;
+    QJsonDocument data;
+};
+
+struct IPCSession {
+    QString path;
+    QString peer;
+    qint64 wall = 0; // ms since epoch when the connection opened
+    QList<IPCFrame> frames;
+
+    qint64 duration() const { return frames.isEmpty() ? 0 : frames.last().t; }
+
+    // Loads a session file written by IPCSessionRecorder.
+    static bool load(const QString &path, IPCSession &session, QString *error = nullptr);
+
+    // Loads every session file found in the given files and directories,
+    // ordered by the time they were recorded.
+    static QList<IPCSession> loadAll(const QStringList &paths);
+};
+
+// Writes the frames of one connection as JSON lines, flushing each line so a
+// crashed server still leaves a usable recording behind.
+class IPCSessionRecorder {
+public:
+    IPCSessionRecorder(const QString &dir, const QString &peer);
+
+    ~IPCSessionRecorder();
+
+    bool isOpen() const { return m_file.isOpen(); }
+
+    void record(IPCFrame::Event event, const QJsonDocument &data = {});
+
+private:
+    QFile m_file;
+    QElapsedTimer m_timer;
+};
+
+#endif //IPCRECORD_H
@@ -0,0 +1,324 @@
+//
+// Created by Chow on 2025/7/28.
+//
+
+#include "TransExport.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSaveFile>
+
+static const QByteArray Bom("\xEF\xBB\xBF");
+
+JsonArrayReader::JsonArrayReader(QIODevice *device, qsizetype chunkSize)
+    : m_device(device), m_chunkSize(chunkSize) {
+}
+
+bool JsonArrayReader::fill() {
+    // Drop what has been consumed before growing the buffer.
+    if (m_pos > 0) {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+    QByteArray chunk = m_device->read(m_chunkSize);
+    if (chunk.isEmpty())
+        return false;
+    m_buffer.append(chunk);
+    return true;
+}
+
+bool JsonArrayReader::fail(const QString &error) {
+    m_error = error;
+    m_done = true;
+    return false;
+}
+
+bool JsonArrayReader::skipSpace() {
+    for (;;) {
+        if (m_pos >= m_buffer.size()) {
+            if (not fill())
+                return false;
+            continue;
+        }
+        char c = m_buffer[m_pos];
+        if (' ' != c and '\t' != c and '\r' != c and '\n' != c)
+            return true;
+        ++m_pos;
+    }
+}
+
+bool JsonArrayReader::next(QJsonValue &value) {
+    if (m_done)
+        return false;
+
+    if (not m_started) {
+        while (m_buffer.size() < Bom.size() and fill()) {
+        }
+        if (m_buffer.startsWith(Bom)) {
+            m_bom = true;
+            m_pos += Bom.size();
+        }
+        if (not skipSpace() or '[' != m_buffer[m_pos])
+            return fail("not a JSON array");
+        m_started = true;
+        ++m_pos;
+    }
+
+    // Exactly one comma between rows, none before the first or after the last.
+    if (not skipSpace())
+        return fail("unexpected end of file");
+    if (m_index > 0) {
+        if (']' != m_buffer[m_pos] and ',' != m_buffer[m_pos])
+            return fail(QString("expected ',' after row %1").arg(m_index - 1));
+        if (',' == m_buffer[m_pos]) {
+            ++m_pos;
+            if (not skipSpace())
+                return fail("unexpected end of file");
+            if (']' == m_buffer[m_pos])
+                return fail(QString("trailing comma after row %1").arg(m_index - 1));
+        }
+    }
+    if (']' == m_buffer[m_pos]) {
+        ++m_pos;
+        m_done = true;
+        if (skipSpace())
+            return fail("unexpected data after the array");
+        return false;
+    }
+
+    // null is what "Insert Item" leaves behind; pass it on so the caller can
+    // report it as an alignment problem.
+    if ('n' == m_buffer[m_pos]) {
+        while (m_buffer.size() - m_pos < 4 and fill()) {
+        }
+        if (m_buffer.mid(m_pos, 4) != "null")
+            return fail(QString("row %1 is not an object").arg(m_index));
+        m_pos += 4;
+        m_raw.clear();
+        value = QJsonValue(QJsonValue::Null);
+        ++m_index;
+        return true;
+    }
+    if ('{' != m_buffer[m_pos])
+        return fail(QString("row %1 is not an object").arg(m_index));
+
+    // Find where it ends; fill() shifts the buffer, so keep i relative to m_pos.
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    for (qsizetype i = m_pos;; ++i) {
+        if (i >= m_buffer.size()) {
+            qsizetype shift = m_pos;
+            if (not fill())
+                return fail("unexpected end of file");
+            i -= shift;
+        }
+        char c = m_buffer[i];
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if ('\\' == c)
+                escaped = true;
+            else if ('"' == c)
+                inString = false;
+            continue;
+        }
+        if ('"' == c) {
+            inString = true;
+        } else if ('{' == c or '[' == c) {
+            ++depth;
+        } else if ('}' == c or ']' == c) {
+            if (0 == --depth) {
+                m_raw = m_buffer.mid(m_pos, i - m_pos + 1);
+                m_pos = i + 1;
+                QJsonParseError parseError;
+                auto doc = QJsonDocument::fromJson(m_raw, &parseError);
+                if (parseError.error != QJsonParseError::NoError)
+                    return fail(QString("row %1: %2").arg(m_index).arg(parseError.errorString()));
+                value = doc.object();
+                ++m_index;
+                return true;
+            }
+        }
+    }
+}
+
+// QJsonObject sorts its keys, so recover their order from the row's text.
+static QStringList keyOrder(const QByteArray &raw) {
+    QStringList keys;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i < raw.size(); ++i) {
+        char c = raw[i];
+        if (inString) {
+            if (escaped) {
+                escaped = false;
+            } else if ('\\' == c) {
+                escaped = true;
+            } else if ('"' == c) {
+                inString = false;
+                qsizetype j = i + 1;
+                while (j < raw.size() and QChar::isSpace(uchar(raw[j])))
+                    ++j;
+                if (1 == depth and j < raw.size() and ':' == raw[j]) {
+                    auto doc = QJsonDocument::fromJson("[" + raw.mid(start, i - start + 1) + "]");
+                    keys.append(doc.array().first().toString());
+                }
+            }
+            continue;
+        }
+        if ('"' == c) {
+            inString = true;
+            start = i;
+        } else if ('{' == c or '[' == c) {
+            ++depth;
+        } else if ('}' == c or ']' == c) {
+            --depth;
+        }
+    }
+    return keys;
+}
+
+// Writes a row the way trans_api does (json.dump with indent=2); values
+// nested inside a row stay on one line.
+static QByteArray formatRow(const QJsonObject &row, const QStringList &order) {
+    const auto compact = [](const QJsonValue &value) {
+        QByteArray json = QJsonDocument(QJsonArray{value}).toJson(QJsonDocument::Compact);
+        return json.mid(1, json.size() - 2);
+    };
+
+    QStringList keys = order;
+    for (const auto &key: row.keys()) {
+        if (not keys.contains(key))
+            keys.append(key);
+    }
+    QByteArray text = "  {";
+    bool first = true;
+    for (const auto &key: keys) {
+        if (not row.contains(key))
+            continue;
+        text += first ? "\n    " : ",\n    ";
+        text += compact(key) + ": " + compact(row[key]);
+        first = false;
+    }
+    text += first ? "}" : "\n  }";
+    return text;
+}
+
+// A row lines up when it is not the empty placeholder left by "Insert Item"
+// and it has a speaker and a message wherever the original has one.
+static bool checkAligned(const QJsonObject &orig, const QJsonValue &trans, QString &why) {
+    if (trans.isNull() or trans.toObject().isEmpty()) {
+        why = "empty translation";
+        return false;
+    }
+    QJsonObject obj = trans.toObject();
+    if (orig["name"].toString().isEmpty() != obj["name"].toString().isEmpty()) {
+        why = QString("speaker \"%1\" translated as \"%2\"")
+                .arg(orig["name"].toString(), obj["name"].toString());
+        return false;
+    }
+    if (not orig["message"].toString().isEmpty() and obj["message"].toString().isEmpty()) {
+        why = "missing message";
+        return false;
+    }
+    return true;
+}
+
+TransExportResult exportTrans(const TransExportJob &job) {
+    QElapsedTimer timer;
+    timer.start();
+
+    TransExportResult result;
+    result.name = QFileInfo(job.origPath).fileName();
+    const auto fail = [&](const QString &error) {
+        result.error = error;
+        result.elapsedMs = timer.elapsed();
+        return result;
+    };
+
+    QFile origFile(job.origPath);
+    if (not origFile.open(QIODevice::ReadOnly))
+        return fail("orig: " + origFile.errorString());
+    QFile transFile(job.transPath);
+    if (not transFile.open(QIODevice::ReadOnly))
+        return fail("trans: " + transFile.errorString());
+
+    // Not committed unless every row checks out, so a failed export never
+    // leaves a partial file behind.
+    QSaveFile out(job.outPath);
+    if (not out.open(QIODevice::WriteOnly))
+        return fail("out: " + out.errorString());
+
+    JsonArrayReader origReader(&origFile);
+    JsonArrayReader transReader(&transFile);
+    const auto countRest = [](JsonArrayReader &reader, qsizetype rows) {
+        QJsonValue value;
+        while (reader.next(value))
+            ++rows;
+        return rows;
+    };
+
+    bool begun = false;
+    const auto begin = [&]() {
+        if (begun)
+            return;
+        begun = true;
+        if (origReader.hasBom())
+            out.write(Bom);
+        out.write("[");
+    };
+
+    for (;;) {
+        QJsonValue orig, trans;
+        bool hasOrig = origReader.next(orig);
+        bool hasTrans = transReader.next(trans);
+        if (origReader.hasError())
+            return fail("orig: " + origReader.errorString());
+        if (transReader.hasError())
+            return fail("trans: " + transReader.errorString());
+        if (not hasOrig and not hasTrans)
+            break;
+        if (hasOrig != hasTrans) {
+            qsizetype origRows = hasOrig ? countRest(origReader, result.rows + 1) : result.rows;
+            qsizetype transRows = hasTrans ? countRest(transReader, result.rows + 1) : result.rows;
+            return fail(QString("row count mismatch: orig %1, trans %2").arg(origRows).arg(transRows));
+        }
+
+        if (not orig.isObject())
+            return fail(QString("orig: row %1 is not an object").arg(result.rows));
+        QJsonObject row = orig.toObject();
+        QStringList order = keyOrder(origReader.raw());
+        QString why;
+        if (not checkAligned(row, trans, why))
+            return fail(QString("row %1 misaligned: %2").arg(result.rows).arg(why));
+        QJsonObject translated = trans.toObject();
+        for (const char *key: {"name", "message"}) {
+            if (translated.contains(key))
+                row[key] = translated[key];
+        }
+
+        begin();
+        out.write(0 == result.rows ? "\n" : ",\n");
+        out.write(formatRow(row, order));
+        ++result.rows;
+    }
+    begin();
+    out.write(0 == result.rows ? "]\n" : "\n]\n");
+
+    // Windows refuses to rename over a file that is still open, which is
+    // exactly the case when merging back into the orig directory.
+    origFile.close();
+    transFile.close();
+    if (not out.commit())
+        return fail("out: " + out.errorString());
+    result.ok = true;
+    result.elapsedMs = timer.elapsed();
+    return result;
+}
@@ -0,0 +1,73 @@
+//
+// Created by Chow on 2025/7/28.
+//
+
+#ifndef TRANSEXPORT_H
+#define TRANSEXPORT_H
+
+#include <QByteArray>
+#include <QJsonValue>
+#include <QString>
+
+class QIODevice;
+
+// Reads the elements of a top-level JSON array one at a time, so only one
+// chunk and one element are held in memory however large the file is.
+class JsonArrayReader {
+public:
+    explicit JsonArrayReader(QIODevice *device, qsizetype chunkSize = 64 * 1024);
+
+    // Returns false at the end of the array or on error; check hasError().
+    // Rows must be objects or null.
+    bool next(QJsonValue &value);
+
+    // Text of the last object row, empty after a null row.
+    const QByteArray &raw() const { return m_raw; }
+
+    bool hasError() const { return not m_error.isEmpty(); }
+
+    QString errorString() const { return m_error; }
+
+    // Whether the file started with a UTF-8 BOM (as written by trans_api).
+    bool hasBom() const { return m_bom; }
+
+private:
+    bool fill();
+
+    // Skips whitespace; returns false at the end of the file.
+    bool skipSpace();
+
+    bool fail(const QString &error);
+
+    QIODevice *m_device;
+    qsizetype m_chunkSize;
+    QByteArray m_buffer;
+    QByteArray m_raw;
+    qsizetype m_pos = 0;
+    qsizetype m_index = 0;
+    bool m_started = false;
+    bool m_done = false;
+    bool m_bom = false;
+    QString m_error;
+};
+
+struct TransExportJob {
+    QString origPath;
+    QString transPath;
+    QString outPath;
+};
+
+struct TransExportResult {
+    QString name;
+    qsizetype rows = 0;
+    qint64 elapsedMs = 0;
+    bool ok = false;
+    QString error;
+};
+
+// Streams an orig/trans pair row by row, checks that they line up and writes
+// the orig rows with the translated name/message to outPath. The output is
+// written to a temporary file and only renamed into place on success.
+TransExportResult exportTrans(const TransExportJob &job);
+
+#endif //TRANSEXPORT_H
@@ -6,6 +6,7 @@
 
 #include <QFile>
 #include <QJsonDocument>
+#include <QCommandLineParser>
 
 #include <iostream>
 
@@ -34,7 +35,25 @@ int main(int argc, char *argv[]) {
     app.setQuitOnLastWindowClosed(false);
     qInstallMessageHandler(MessageHandler);
 
-    IPC ipc;
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption portOption("port", "IPC server port.", "port", "12345");
+    QCommandLineOption recordOption("record", "Record IPC sessions into <dir>.", "dir");
+    QCommandLineOption reviewOption("review",
+                                    "How requests are reviewed: dialog, accept, reject "
+                                    "or the path of a review script.",
+                                    "review", "dialog");
+    parser.addOptions({portOption, recordOption, reviewOption});
+    parser.process(app);
+
+    auto reviewer = IPC::reviewerFromSpec(parser.value(reviewOption));
+    if (not reviewer) {
+        return 1;
+    }
+
+    IPC ipc(parser.value(portOption).toUShort());
+    ipc.setReviewer(reviewer);
+    ipc.setRecordDir(parser.value(recordOption));
 
     return QApplication::exec();
 }
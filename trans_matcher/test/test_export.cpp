@@ -0,0 +1,221 @@
+//
+// Created by Chow on 2025/7/29.
+//
+#include <QtTest>
+#include "core/TransExport.h"
+
+#include <QBuffer>
+#include <QDir>
+#include <QFile>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+class TestExport : public QObject {
+    Q_OBJECT
+
+    struct Read {
+        QList<QJsonValue> rows;
+        QString error;
+        bool bom = false;
+    };
+
+    static Read readAll(const QByteArray &data, qsizetype chunkSize = 64 * 1024) {
+        QBuffer buffer;
+        buffer.setData(data);
+        buffer.open(QIODevice::ReadOnly);
+        JsonArrayReader reader(&buffer, chunkSize);
+        Read read;
+        QJsonValue value;
+        while (reader.next(value))
+            read.rows.append(value);
+        read.error = reader.errorString();
+        read.bom = reader.hasBom();
+        return read;
+    }
+
+    static void writeFile(const QString &path, const QByteArray &data) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    QTemporaryDir m_dir;
+
+    TransExportJob makeJob(const QByteArray &orig, const QByteArray &trans) {
+        TransExportJob job{
+            m_dir.filePath("orig.json"), m_dir.filePath("trans.json"), m_dir.filePath("out/out.json")
+        };
+        QDir(m_dir.path()).mkpath("out");
+        writeFile(job.origPath, orig);
+        writeFile(job.transPath, trans);
+        return job;
+    }
+
+    // Nothing, not even QSaveFile's temporary, may be left after a failure.
+    void verifyNoOutput() {
+        QVERIFY(QDir(m_dir.filePath("out")).isEmpty(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden));
+    }
+
+private slots:
+    void init() {
+        QVERIFY(m_dir.isValid());
+        QDir(m_dir.filePath("out")).removeRecursively();
+    }
+
+    void readerRows() {
+        auto read = readAll(R"( [ {"a": 1}, null ,{"b": "x,]}"} ] )");
+        QCOMPARE(read.error, QString());
+        QCOMPARE(read.rows.size(), qsizetype(3));
+        QCOMPARE(read.rows[0].toObject()["a"].toInt(), 1);
+        QVERIFY(read.rows[1].isNull());
+        QCOMPARE(read.rows[2].toObject()["b"].toString(), QString("x,]}"));
+    }
+
+    void readerEmptyArray() {
+        auto read = readAll("[]\n");
+        QCOMPARE(read.error, QString());
+        QVERIFY(read.rows.isEmpty());
+    }
+
+    void readerChunkBoundary() {
+        QByteArray row = R"({"name": "A", "message": ")" + QByteArray(100, 'x') + R"(\"q\""})";
+        QByteArray data = "[" + row + ",\n null,\n" + row + "]";
+        for (qsizetype chunk: {1, 2, 3, 7, 64}) {
+            auto read = readAll(data, chunk);
+            QCOMPARE(read.error, QString());
+            QCOMPARE(read.rows.size(), qsizetype(3));
+            QVERIFY(read.rows[1].isNull());
+            QCOMPARE(read.rows[2].toObject()["message"].toString(),
+                     QString(100, 'x') + "\"q\"");
+        }
+    }
+
+    void readerBom() {
+        auto read = readAll("\xEF\xBB\xBF[{}]", 2);
+        QCOMPARE(read.error, QString());
+        QVERIFY(read.bom);
+        QCOMPARE(read.rows.size(), qsizetype(1));
+        QVERIFY(not readAll("[{}]").bom);
+    }
+
+    void readerRejects_data() {
+        QTest::addColumn<QByteArray>("data");
+        QTest::newRow("leading comma") << QByteArray("[,{}]");
+        QTest::newRow("doubled comma") << QByteArray("[{},,{}]");
+        QTest::newRow("trailing comma") << QByteArray("[{},{},]");
+        QTest::newRow("missing comma") << QByteArray("[{} {}]");
+        QTest::newRow("trailing data") << QByteArray("[{}] x");
+        QTest::newRow("second array") << QByteArray("[{}][]");
+        QTest::newRow("array row") << QByteArray("[[1]]");
+        QTest::newRow("string row") << QByteArray("[\"a\"]");
+        QTest::newRow("bad null") << QByteArray("[nul]");
+        QTest::newRow("not an array") << QByteArray("{}");
+        QTest::newRow("empty file") << QByteArray();
+        QTest::newRow("unterminated row") << QByteArray("[{\"a\": 1");
+        QTest::newRow("unterminated array") << QByteArray("[{}");
+        QTest::newRow("invalid row") << QByteArray("[{\"a\" 1}]");
+    }
+
+    void readerRejects() {
+        QFETCH(QByteArray, data);
+        for (qsizetype chunk: {1, 64 * 1024})
+            QVERIFY(not readAll(data, chunk).error.isEmpty());
+    }
+
+    void exportMerges() {
+        auto j = makeJob(R"([{"name": "A", "message": "m1", "id": 1}, {"name": "", "message": "m2"}])",
+                     R"([{"name": "B", "message": "t1"}, {"name": "", "message": "t2"}])");
+        auto result = exportTrans(j);
+        QVERIFY2(result.ok, qPrintable(result.error));
+        QCOMPARE(result.rows, qsizetype(2));
+
+        QFile out(j.outPath);
+        QVERIFY(out.open(QIODevice::ReadOnly));
+        QCOMPARE(out.readAll(), QByteArray(
+                     "[\n"
+                     "  {\n"
+                     "    \"name\": \"B\",\n"
+                     "    \"message\": \"t1\",\n"
+                     "    \"id\": 1\n"
+                     "  },\n"
+                     "  {\n"
+                     "    \"name\": \"\",\n"
+                     "    \"message\": \"t2\"\n"
+                     "  }\n"
+                     "]\n"));
+    }
+
+    void exportKeepsBom() {
+        auto j = makeJob("\xEF\xBB\xBF[{\"message\": \"m\"}]", "[{\"message\": \"t\"}]");
+        auto result = exportTrans(j);
+        QVERIFY2(result.ok, qPrintable(result.error));
+        QFile out(j.outPath);
+        QVERIFY(out.open(QIODevice::ReadOnly));
+        QVERIFY(out.readAll().startsWith("\xEF\xBB\xBF["));
+    }
+
+    void exportOverwritesOrig() {
+        auto j = makeJob(R"([{"message": "m"}])", R"([{"message": "t"}])");
+        j.outPath = j.origPath;
+        auto result = exportTrans(j);
+        QVERIFY2(result.ok, qPrintable(result.error));
+        QFile out(j.outPath);
+        QVERIFY(out.open(QIODevice::ReadOnly));
+        QVERIFY(out.readAll().contains("\"t\""));
+    }
+
+    void exportFails_data() {
+        QTest::addColumn<QByteArray>("orig");
+        QTest::addColumn<QByteArray>("trans");
+        QTest::addColumn<QString>("error");
+        QTest::newRow("more orig rows")
+                << QByteArray(R"([{"message": "a"}, {"message": "b"}, {"message": "c"}])")
+                << QByteArray(R"([{"message": "x"}])")
+                << QString("row count mismatch: orig 3, trans 1");
+        QTest::newRow("more trans rows")
+                << QByteArray(R"([{"message": "a"}])")
+                << QByteArray(R"([{"message": "x"}, {"message": "y"}])")
+                << QString("row count mismatch: orig 1, trans 2");
+        QTest::newRow("inserted null")
+                << QByteArray(R"([{"message": "a"}])")
+                << QByteArray("[null]")
+                << QString("row 0 misaligned: empty translation");
+        QTest::newRow("inserted empty object")
+                << QByteArray(R"([{"message": "a"}, {"message": "b"}])")
+                << QByteArray(R"([{"message": "x"}, {}])")
+                << QString("row 1 misaligned: empty translation");
+        QTest::newRow("speaker shifted")
+                << QByteArray(R"([{"name": "A", "message": "a"}])")
+                << QByteArray(R"([{"message": "x"}])")
+                << QString("row 0 misaligned: speaker \"A\" translated as \"\"");
+        QTest::newRow("missing message")
+                << QByteArray(R"([{"message": "a"}])")
+                << QByteArray(R"([{"message": ""}])")
+                << QString("row 0 misaligned: missing message");
+        QTest::newRow("null orig row")
+                << QByteArray("[null]")
+                << QByteArray(R"([{"message": "x"}])")
+                << QString("orig: row 0 is not an object");
+        QTest::newRow("array orig row")
+                << QByteArray("[[1]]")
+                << QByteArray(R"([{"message": "x"}])")
+                << QString("orig: row 0 is not an object");
+        QTest::newRow("malformed trans")
+                << QByteArray(R"([{"message": "a"}, {"message": "b"}])")
+                << QByteArray(R"([{"message": "x"} {"message": "y"}])")
+                << QString("trans: expected ',' after row 0");
+    }
+
+    void exportFails() {
+        QFETCH(QByteArray, orig);
+        QFETCH(QByteArray, trans);
+        QFETCH(QString, error);
+        auto result = exportTrans(makeJob(orig, trans));
+        QVERIFY(not result.ok);
+        QCOMPARE(result.error, error);
+        verifyNoOutput();
+    }
+};
+
+QTEST_GUILESS_MAIN(TestExport)
+#include "test_export.moc"
@@ -0,0 +1,124 @@
+//
+// Created by Chow on 2025/7/28.
+//
+// Merges reviewed translations back into the original script rows, one
+// orig/trans file pair per worker thread.
+//
+#include <QCoreApplication>
+#include "core/TransExport.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <iostream>
+
+void MessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
+    switch (type) {
+        case QtInfoMsg:
+            std::cout << "Info: " << msg.toStdString() << std::endl;
+            break;
+        case QtDebugMsg:
+            std::cout << "Debug: " << msg.toStdString() << std::endl;
+            break;
+        case QtWarningMsg:
+            std::cout << "Warning: " << msg.toStdString() << std::endl;
+            break;
+        case QtCriticalMsg:
+            std::cout << "Critical: " << msg.toStdString() << std::endl;
+            break;
+        case QtFatalMsg:
+            std::cout << "Fatal: " << msg.toStdString() << std::endl;
+            abort();
+    }
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(MessageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Merges accepted translations into the original script rows.\n"
+        "Rows keep the key order of the orig file and are written in the\n"
+        "indent=2 layout of trans_api; values nested in a row stay on one line.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("orig", "Directory of original *.json scripts.");
+    parser.addPositionalArgument("trans", "Directory of translations with the same file names.");
+    parser.addPositionalArgument("out", "Directory to write the merged scripts to.");
+    QCommandLineOption jobsOption("jobs", "Worker threads, defaults to one per core.", "n");
+    parser.addOption(jobsOption);
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 3) {
+        parser.showHelp(1);
+    }
+    QDir origDir(args[0]), transDir(args[1]), outDir(args[2]);
+    for (const auto &dir: {origDir, transDir}) {
+        if (not dir.exists()) {
+            qCritical() << "No such directory" << dir.path();
+            return 1;
+        }
+    }
+    if (not outDir.mkpath(".")) {
+        qCritical() << "Failed to create output directory" << outDir.path();
+        return 1;
+    }
+    if (parser.isSet(jobsOption)) {
+        QThreadPool::globalInstance()->setMaxThreadCount(
+            std::max(1, parser.value(jobsOption).toInt()));
+    }
+
+    QList<TransExportJob> jobs;
+    int missing = 0;
+    for (const auto &name: origDir.entryList({"*.json"}, QDir::Files, QDir::Name)) {
+        if (not transDir.exists(name)) {
+            qWarning() << "No translation for" << name;
+            ++missing;
+            continue;
+        }
+        jobs.append({origDir.filePath(name), transDir.filePath(name), outDir.filePath(name)});
+    }
+    qInfo() << "Exporting" << jobs.size() << "files on"
+            << QThreadPool::globalInstance()->maxThreadCount() << "threads";
+
+    QElapsedTimer timer;
+    timer.start();
+    auto results = QtConcurrent::blockingMapped<QList<TransExportResult> >(jobs, exportTrans);
+    qint64 wallMs = timer.elapsed();
+
+    auto line = [](const QString &text) { std::cout << text.toStdString() << std::endl; };
+    int failed = 0;
+    qsizetype rows = 0;
+    qint64 busyMs = 0;
+    for (const auto &result: results) {
+        busyMs += result.elapsedMs;
+        if (result.ok) {
+            rows += result.rows;
+            line(QString("  %1  %2 rows  %3 ms")
+                    .arg(result.name, -32).arg(result.rows, 7).arg(result.elapsedMs, 6));
+        } else {
+            ++failed;
+            line(QString("  %1  FAILED  %2 ms  %3")
+                    .arg(result.name, -32).arg(result.elapsedMs, 6).arg(result.error));
+        }
+    }
+
+    std::sort(results.begin(), results.end(),
+              [](const TransExportResult &a, const TransExportResult &b) {
+                  return a.elapsedMs > b.elapsedMs;
+              });
+    line(QString("Exported %1 of %2 files (%3 failed, %4 without translation), %5 rows")
+            .arg(jobs.size() - failed).arg(jobs.size()).arg(failed).arg(missing).arg(rows));
+    line(QString("Wall time: %1 ms, summed file time: %2 ms, slowest: %3 (%4 ms)")
+            .arg(wallMs).arg(busyMs)
+            .arg(results.isEmpty() ? QString("-") : results.first().name)
+            .arg(results.isEmpty() ? 0 : results.first().elapsedMs));
+
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,438 @@
+//
+// Created by Chow on 2025/7/27.
+//
+// Replays recorded IPC sessions (see `trans_matcher --record`) against an IPC
+// server and reports throughput, latency and server memory over time.
+//
+#include <QCoreApplication>
+#include "core/IPC.h"
+#include "core/IPCRecord.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef Q_OS_WIN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+void MessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg) {
+    switch (type) {
+        case QtInfoMsg:
+            std::cout << "Info: " << msg.toStdString() << std::endl;
+            break;
+        case QtDebugMsg:
+            std::cout << "Debug: " << msg.toStdString() << std::endl;
+            break;
+        case QtWarningMsg:
+            std::cout << "Warning: " << msg.toStdString() << std::endl;
+            break;
+        case QtCriticalMsg:
+            std::cout << "Critical: " << msg.toStdString() << std::endl;
+            break;
+        case QtFatalMsg:
+            std::cout << "Fatal: " << msg.toStdString() << std::endl;
+            abort();
+    }
+}
+
+// Resident memory of a process in bytes, or -1 if it cannot be read.
+static qint64 residentBytes(qint64 pid) {
+#if defined(Q_OS_WIN)
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, DWORD(pid));
+    if (nullptr == process)
+        return -1;
+    PROCESS_MEMORY_COUNTERS counters;
+    qint64 bytes = -1;
+    if (K32GetProcessMemoryInfo(process, &counters, sizeof(counters)))
+        bytes = qint64(counters.WorkingSetSize);
+    CloseHandle(process);
+    return bytes;
+#elif defined(Q_OS_LINUX)
+    QFile status(QString("/proc/%1/status").arg(pid));
+    if (not status.open(QIODevice::ReadOnly))
+        return -1;
+    while (not status.atEnd()) {
+        QByteArray line = status.readLine();
+        if (line.startsWith("VmRSS:"))
+            return line.mid(6).trimmed().split(' ').first().toLongLong() * 1024;
+    }
+    return -1;
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+// The server writes its replies back to back without a delimiter, so split
+// them by bracket depth. Returns false until a whole document is buffered.
+static bool takeDocument(QByteArray &buffer, QJsonDocument &doc) {
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    qsizetype start = -1;
+    for (qsizetype i = 0; i < buffer.size(); ++i) {
+        char c = buffer[i];
+        if (inString) {
+            if (escaped)
+                escaped = false;
+            else if ('\\' == c)
+                escaped = true;
+            else if ('"' == c)
+                inString = false;
+            continue;
+        }
+        if ('"' == c) {
+            inString = true;
+        } else if ('{' == c or '[' == c) {
+            if (0 == depth++)
+                start = i;
+        } else if (('}' == c or ']' == c) and depth > 0) {
+            if (0 == --depth) {
+                doc = QJsonDocument::fromJson(buffer.mid(start, i - start + 1));
+                buffer.remove(0, i + 1);
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static qint64 percentile(QList<qint64> values, double p) {
+    if (values.isEmpty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    qsizetype idx = qsizetype(p * double(values.size() - 1) + 0.5);
+    return values[std::clamp<qsizetype>(idx, 0, values.size() - 1)];
+}
+
+class Replayer {
+public:
+    struct Options {
+        QString host;
+        quint16 port = 0;
+        int concurrency = 1;
+        double speedup = 1.0;
+        int loops = 1;
+        int timeoutMs = 30000;
+        int sampleMs = 500;
+        qint64 serverPid = -1;
+    };
+
+    Replayer(const QList<IPCSession> &sessions, const Options &options)
+        : m_sessions(sessions), m_options(options) {
+        qint64 first = m_sessions.first().wall;
+        qint64 span = 0;
+        for (const auto &session: m_sessions)
+            span = std::max(span, session.wall - first + session.duration());
+        for (int loop = 0; loop < m_options.loops; ++loop) {
+            for (const auto &session: m_sessions)
+                m_queue.append({&session, scaled(session.wall - first + loop * span)});
+        }
+        std::stable_sort(m_queue.begin(), m_queue.end(),
+                         [](const Job &a, const Job &b) { return a.due < b.due; });
+        m_total = m_queue.size();
+    }
+
+    void start() {
+        m_clock.start();
+        if (m_options.serverPid > 0) {
+            sample();
+            auto sampler = new QTimer(qApp);
+            QObject::connect(sampler, &QTimer::timeout, [this]() { sample(); });
+            sampler->start(m_options.sampleMs);
+        }
+        dispatch();
+    }
+
+    void report() const {
+        qint64 wallMs = std::max<qint64>(m_clock.elapsed(), 1);
+        auto line = [](const QString &text) { std::cout << text.toStdString() << std::endl; };
+        auto latencies = [&line](const char *name, const QList<qint64> &values) {
+            line(QString("%1 latency (ms): p50 %2, p90 %3, p99 %4, max %5")
+                    .arg(name)
+                    .arg(percentile(values, 0.50))
+                    .arg(percentile(values, 0.90))
+                    .arg(percentile(values, 0.99))
+                    .arg(percentile(values, 1.00)));
+        };
+
+        line(QString("Sessions: %1 (errors %2), requests: %3 (accepted %4, rejected %5)")
+                .arg(m_total).arg(m_errors).arg(m_doneLatency.size())
+                .arg(m_accepted).arg(m_rejected));
+        line(QString("Wall time: %1 s, throughput: %2 req/s, concurrency: %3, speed-up: %4")
+                .arg(double(wallMs) / 1000.0, 0, 'f', 2)
+                .arg(double(m_doneLatency.size()) * 1000.0 / double(wallMs), 0, 'f', 2)
+                .arg(m_options.concurrency)
+                .arg(m_options.speedup));
+        latencies("Ack  ", m_ackLatency);
+        latencies("Reply", m_doneLatency);
+
+        if (m_memory.isEmpty())
+            return;
+        line("Server memory (RSS):");
+        // Keep the table readable for long runs.
+        qsizetype step = std::max<qsizetype>(1, m_memory.size() / 20);
+        qint64 peak = 0;
+        for (qsizetype i = 0; i < m_memory.size(); ++i) {
+            peak = std::max(peak, m_memory[i].bytes);
+            if (i % step and i != m_memory.size() - 1)
+                continue;
+            line(QString("  %1 s  %2 MB")
+                    .arg(double(m_memory[i].t) / 1000.0, 8, 'f', 1)
+                    .arg(double(m_memory[i].bytes) / 1048576.0, 8, 'f', 1));
+        }
+        line(QString("  peak %1 MB, growth %2 MB")
+                .arg(double(peak) / 1048576.0, 0, 'f', 1)
+                .arg(double(m_memory.last().bytes - m_memory.first().bytes) / 1048576.0, 0, 'f', 1));
+    }
+
+    bool failed() const { return m_errors > 0; }
+
+private:
+    struct Job {
+        const IPCSession *session;
+        qint64 due;
+    };
+
+    struct Connection {
+        QTcpSocket *socket = nullptr;
+        const IPCSession *session = nullptr;
+        qint64 startedAt = 0;
+        qsizetype next = 0; // index of the next frame to look at
+        qsizetype pending = -1; // index of the request awaiting its reply
+        qint64 sentAt = 0;
+        QByteArray buffer;
+        bool finished = false;
+    };
+
+    struct MemorySample {
+        qint64 t;
+        qint64 bytes;
+    };
+
+    qint64 scaled(qint64 ms) const {
+        return m_options.speedup > 0 ? qint64(double(ms) / m_options.speedup) : 0;
+    }
+
+    void sample() {
+        qint64 bytes = residentBytes(m_options.serverPid);
+        if (bytes >= 0)
+            m_memory.append({m_clock.elapsed(), bytes});
+    }
+
+    void dispatch() {
+        while (not m_queue.isEmpty() and m_inFlight < m_options.concurrency) {
+            qint64 wait = m_queue.first().due - m_clock.elapsed();
+            if (wait > 0) {
+                QTimer::singleShot(int(wait), qApp, [this]() { dispatch(); });
+                return;
+            }
+            open(m_queue.takeFirst().session);
+        }
+    }
+
+    void open(const IPCSession *session) {
+        auto conn = std::make_shared<Connection>();
+        conn->socket = new QTcpSocket(qApp);
+        conn->session = session;
+        conn->startedAt = m_clock.elapsed();
+        ++m_inFlight;
+
+        QObject::connect(conn->socket, &QTcpSocket::connected,
+                         [this,conn]() { sendNext(conn); });
+        QObject::connect(conn->socket, &QTcpSocket::readyRead,
+                         [this,conn]() { onReadyRead(conn); });
+        QObject::connect(conn->socket, &QTcpSocket::errorOccurred,
+                         [this,conn](QAbstractSocket::SocketError) {
+                             if (conn->finished)
+                                 return;
+                             qWarning() << "Session" << conn->session->path
+                                     << "failed:" << conn->socket->errorString();
+                             finish(conn, true);
+                         });
+        conn->socket->connectToHost(m_options.host, m_options.port);
+    }
+
+    void sendNext(const std::shared_ptr<Connection> &conn) {
+        const auto &frames = conn->session->frames;
+        while (conn->next < frames.size() and IPCFrame::Recv != frames[conn->next].event)
+            ++conn->next;
+        if (conn->next >= frames.size()) {
+            finish(conn, false);
+            return;
+        }
+
+        qsizetype idx = conn->next++;
+        qint64 wait = conn->startedAt + scaled(frames[idx].t) - m_clock.elapsed();
+        QTimer::singleShot(int(std::max<qint64>(wait, 0)), conn->socket, [this,conn,idx]() {
+            conn->pending = idx;
+            conn->sentAt = m_clock.elapsed();
+            conn->socket->write(conn->session->frames[idx].data.toJson(QJsonDocument::Compact));
+            QTimer::singleShot(m_options.timeoutMs, conn->socket, [this,conn,idx]() {
+                if (conn->finished or conn->pending != idx)
+                    return;
+                qWarning() << "Session" << conn->session->path << "timed out";
+                finish(conn, true);
+            });
+        });
+    }
+
+    void onReadyRead(const std::shared_ptr<Connection> &conn) {
+        conn->buffer.append(conn->socket->readAll());
+        QJsonDocument doc;
+        while (not conn->finished and takeDocument(conn->buffer, doc)) {
+            QString status = doc.object()["status"].toString();
+            qint64 latency = m_clock.elapsed() - conn->sentAt;
+            if ("received" == status) {
+                m_ackLatency.append(latency);
+                continue;
+            }
+            if ("accepted" == status)
+                ++m_accepted;
+            else if ("rejected" == status)
+                ++m_rejected;
+            else
+                qWarning() << "Unexpected reply" << doc.toJson(QJsonDocument::Compact);
+            m_doneLatency.append(latency);
+            conn->pending = -1;
+            sendNext(conn);
+        }
+    }
+
+    void finish(const std::shared_ptr<Connection> &conn, bool error) {
+        if (conn->finished)
+            return;
+        conn->finished = true;
+        if (error)
+            ++m_errors;
+        conn->socket->disconnectFromHost();
+        conn->socket->deleteLater();
+        --m_inFlight;
+
+        if (++m_completed == m_total) {
+            QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+            return;
+        }
+        dispatch();
+    }
+
+    const QList<IPCSession> &m_sessions;
+    Options m_options;
+    QList<Job> m_queue;
+    QElapsedTimer m_clock;
+
+    qsizetype m_total = 0;
+    qsizetype m_completed = 0;
+    int m_inFlight = 0;
+    int m_errors = 0;
+    int m_accepted = 0;
+    int m_rejected = 0;
+    QList<qint64> m_ackLatency;
+    QList<qint64> m_doneLatency;
+    QList<MemorySample> m_memory;
+};
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    qInstallMessageHandler(MessageHandler);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays recorded IPC sessions against an IPC server.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("sessions", "Session files or directories to replay.", "<sessions...>");
+    QCommandLineOption hostOption("host", "Server host.", "host", "127.0.0.1");
+    QCommandLineOption portOption("port", "Server port.", "port", "12345");
+    QCommandLineOption inProcessOption("in-process",
+                                       "Start an IPC server in this process on a free port "
+                                       "instead of connecting to a running one.");
+    QCommandLineOption reviewOption("review",
+                                    "In-process review: accept, reject or a review script.",
+                                    "review", "accept");
+    QCommandLineOption concurrencyOption("concurrency", "Sessions in flight at once.", "n", "1");
+    QCommandLineOption speedupOption("speedup",
+                                     "Speed-up over the recorded timing, 0 for no pacing.",
+                                     "factor", "1");
+    QCommandLineOption loopsOption("loops", "Number of passes over the sessions.", "n", "1");
+    QCommandLineOption timeoutOption("timeout", "Per-request reply timeout.", "ms", "30000");
+    QCommandLineOption pidOption("server-pid", "Sample the memory of this server process.", "pid");
+    QCommandLineOption sampleOption("sample", "Memory sampling interval.", "ms", "500");
+    parser.addOptions({
+        hostOption, portOption, inProcessOption, reviewOption, concurrencyOption,
+        speedupOption, loopsOption, timeoutOption, pidOption, sampleOption
+    });
+    parser.process(app);
+
+    auto sessions = IPCSession::loadAll(parser.positionalArguments());
+    if (sessions.isEmpty()) {
+        qCritical() << "No sessions to replay";
+        return 1;
+    }
+
+    Replayer::Options options;
+    options.host = parser.value(hostOption);
+    options.port = parser.value(portOption).toUShort();
+    options.concurrency = std::max(1, parser.value(concurrencyOption).toInt());
+    options.speedup = std::max(0.0, parser.value(speedupOption).toDouble());
+    options.loops = std::max(1, parser.value(loopsOption).toInt());
+    options.timeoutMs = std::max(1, parser.value(timeoutOption).toInt());
+    options.sampleMs = std::max(10, parser.value(sampleOption).toInt());
+    if (parser.isSet(pidOption))
+        options.serverPid = parser.value(pidOption).toLongLong();
+
+    // The in-process server gets a thread of its own so that its event loop
+    // is not shared with the clients; memory then covers both sides.
+    QThread serverThread;
+    QObject serverContext;
+    IPC *server = nullptr;
+    if (parser.isSet(inProcessOption)) {
+        QString review = parser.value(reviewOption);
+        auto reviewer = review.isEmpty() or "dialog" == review
+                            ? IPC::Reviewer{} : IPC::reviewerFromSpec(review);
+        if (not reviewer) {
+            qCritical() << "In-process replay needs a non-interactive review";
+            return 1;
+        }
+        serverContext.moveToThread(&serverThread);
+        serverThread.start();
+        QMetaObject::invokeMethod(&serverContext, [&]() {
+            server = new IPC(parser.isSet(portOption) ? options.port : 0);
+            server->setReviewer(reviewer);
+        }, Qt::BlockingQueuedConnection);
+        options.host = "127.0.0.1";
+        options.port = server->serverPort();
+        if (options.serverPid < 0)
+            options.serverPid = QCoreApplication::applicationPid();
+    }
+
+    int ret = 0;
+    if (0 == options.port) {
+        qCritical() << "No server to replay against";
+        ret = 1;
+    } else {
+        qInfo() << "Replaying" << sessions.size() << "sessions against"
+                << options.host << ":" << options.port;
+        Replayer replayer(sessions, options);
+        replayer.start();
+        QCoreApplication::exec();
+        replayer.report();
+        ret = replayer.failed() ? 2 : 0;
+    }
+
+    if (server) {
+        QMetaObject::invokeMethod(&serverContext, [&]() { delete server; },
+                                  Qt::BlockingQueuedConnection);
+        serverThread.quit();
+        serverThread.wait();
+    }
+    return ret;
+}